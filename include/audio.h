@@ -0,0 +1,18 @@
+// Audio analysis pipeline, free of Arduino calls so it can be fed from any sample source (ie. a WAV file on the host)
+#pragma once
+
+#include <stdint.h>
+
+#ifndef AUDIO_SAMPLE_RATE
+#define AUDIO_SAMPLE_RATE 2000 // Hz, the band frequencies scale with it
+#endif
+#define AUDIO_RING_SIZE 128 // power of two
+#define AUDIO_FFT_SIZE 64
+#define AUDIO_BANDS 8
+
+extern uint8_t audioLevels[AUDIO_BANDS];
+
+void audioReset();
+void audioPushSample(uint16_t sample);
+void audioGap();
+bool audioProcess();
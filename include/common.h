@@ -1,7 +1,111 @@
 #include <NeoPixelBus.h>
 #include <SimpleTimer.h>
 
+#ifdef NATIVE
+#include "config_native.h" // fixed configuration for the host tests
+#else
 #include "config.h"
+#endif
+
+// Pixel format of the effect buffers, RGB strips don't need to carry a white value around
+#ifdef PIXEL_FORMAT_RGB
+typedef RgbColor LedColor;
+#else
+typedef RgbwColor LedColor;
+#endif
+
+inline void convertColor(const RgbwColor &from, RgbwColor &to)
+{
+    to = from;
+}
+
+inline void convertColor(const RgbwColor &from, RgbColor &to)
+{
+    // Without a white led the white value is mixed into the colors
+    to = RgbColor(min(from.R + from.W, 255), min(from.G + from.W, 255), min(from.B + from.W, 255));
+}
+
+inline void convertColor(const RgbColor &from, RgbwColor &to)
+{
+    to = RgbwColor(from);
+}
+
+inline void convertColor(const RgbColor &from, RgbColor &to)
+{
+    to = from;
+}
+
+template <typename T_COLOR>
+struct PixelFormat;
+
+template <>
+struct PixelFormat<RgbwColor>
+{
+    static const int Channels = 4;
+
+    static RgbwColor make(uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+    {
+        return RgbwColor(r, g, b, w);
+    }
+
+    static RgbwColor scale(const RgbwColor &color, float multiplier)
+    {
+        return RgbwColor(color.R * multiplier, color.G * multiplier, color.B * multiplier, color.W * multiplier);
+    }
+
+    // Channels in R, G, B, W order
+    static uint8_t &channel(RgbwColor &color, int i)
+    {
+        switch (i)
+        {
+        case 0:
+            return color.R;
+        case 1:
+            return color.G;
+        case 2:
+            return color.B;
+        default:
+            return color.W;
+        }
+    }
+};
+
+template <>
+struct PixelFormat<RgbColor>
+{
+    static const int Channels = 3;
+
+    static RgbColor make(uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+    {
+        RgbColor color;
+        convertColor(RgbwColor(r, g, b, w), color);
+        return color;
+    }
+
+    static RgbColor scale(const RgbColor &color, float multiplier)
+    {
+        return RgbColor(color.R * multiplier, color.G * multiplier, color.B * multiplier);
+    }
+
+    // Channels in R, G, B order
+    static uint8_t &channel(RgbColor &color, int i)
+    {
+        switch (i)
+        {
+        case 0:
+            return color.R;
+        case 1:
+            return color.G;
+        default:
+            return color.B;
+        }
+    }
+};
+
+inline LedColor makeColor(uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+{
+    return PixelFormat<LedColor>::make(r, g, b, w);
+}
 
 enum Effect
 {
@@ -9,12 +113,13 @@ enum Effect
     eGradient,
     eCustom,
     eSunrise,
-    eColorLoop
+    eColorLoop,
+    eAudio
 };
 
 extern SimpleTimer timer;
-extern RgbwColor stripLeds[NUM_LEDS];
-extern RgbwColor customLeds[NUM_LEDS];
+extern LedColor stripLeds[NUM_LEDS];
+extern LedColor customLeds[NUM_LEDS];
 extern byte enabledLeds[NUM_LEDS / 8 + 1];
 extern Effect effect;
 extern uint8_t red;
@@ -24,7 +129,53 @@ extern uint8_t white;
 extern char gradientMode;
 extern int gradientExtent;
 extern int sunriseDuration;
+extern uint16_t colorLoopSpeed;
+extern uint16_t colorLoopSpread;
+extern uint8_t colorLoopSaturation;
+extern const uint8_t colorLoopWave[256];
+extern unsigned long audioDroppedSamples;
+extern bool on;
+extern char effectStr[64];
+extern uint8_t colorRed;
+extern uint8_t colorGreen;
+extern uint8_t colorBlue;
+extern uint8_t brightness;
+extern int transition;
+extern int transitionCounter;
+extern unsigned long messageCount;
+extern unsigned long messageMicros;
+extern unsigned long maxMessageMicros;
+extern unsigned long frameCount;
+extern unsigned long frameMicros;
+extern unsigned long maxFrameMicros;
+extern unsigned long httpMicros;
+extern unsigned long maxHttpMicros;
+
+// MQTT client access, provided by main.cpp
+void mqttPublish(const char *topic, const char *payload, bool retained);
+void mqttUnsubscribe(const char *topic);
+
+void callback(char *topic, byte *payload, unsigned int length);
+void handleCommand(const char *payload);
+void handleWakeAlarm(int duration);
+bool handleSetGradient(const char *payload);
+bool handleSetColorLoop(const char *payload);
+void handleSetCustom(const char *payload);
+void handleSetEnabledLeds(const char *payload);
+void formatAttributes(char *buf, size_t size);
+void publishAttrChange();
+void publishStateChange();
+void setupHttpApi();
 
+void setupOutputs();
+void setOutputPixel(int i, const LedColor &color);
+LedColor getOutputPixel(int i);
+void showOutputs();
+void buildColorLoopTable();
+void audio();
+void audioLoop();
+void audioSample();
+void startAudio();
 void sunrise();
 void startEffect(Effect e);
 void startSunrise(int duration);
@@ -0,0 +1,280 @@
+///////////////////////////////////////////////////////////////////////
+// Audio reactive effect. Samples A0 into a ring buffer and runs a   //
+// fixed point FFT in small slices between frames to get band levels //
+///////////////////////////////////////////////////////////////////////
+
+#include <Arduino.h>
+
+#include "common.h"
+#include "audio.h"
+
+enum AudioStep
+{
+    eAudioIdle,
+    eAudioWindow,
+    eAudioStages01,
+    eAudioStages23,
+    eAudioStages45,
+    eAudioBands
+};
+
+// sin(2 * pi * k / AUDIO_FFT_SIZE) in Q15, cosine is the same table a quarter turn later
+const int16_t audioSine[AUDIO_FFT_SIZE] PROGMEM = {
+    0, 3212, 6393, 9512, 12539, 15446, 18204, 20787, 23170, 25329, 27245, 28898, 30273, 31356, 32137, 32609,
+    32767, 32609, 32137, 31356, 30273, 28898, 27245, 25329, 23170, 20787, 18204, 15446, 12539, 9512, 6393, 3212,
+    0, -3212, -6393, -9512, -12539, -15446, -18204, -20787, -23170, -25329, -27245, -28898, -30273, -31356, -32137, -32609,
+    -32767, -32609, -32137, -31356, -30273, -28898, -27245, -25329, -23170, -20787, -18204, -15446, -12539, -9512, -6393, -3212};
+// First FFT bin of each band, roughly logarithmic, the last entry is the end of the last band
+const uint8_t audioBandBins[AUDIO_BANDS + 1] = {1, 2, 3, 5, 7, 10, 14, 20, AUDIO_FFT_SIZE / 2};
+
+#define AUDIO_NOISE_FLOOR 64
+
+uint16_t audioRing[AUDIO_RING_SIZE];
+uint8_t audioRingHead = 0;
+uint8_t audioNewSamples = 0;
+int16_t audioReal[AUDIO_FFT_SIZE];
+int16_t audioImag[AUDIO_FFT_SIZE];
+int32_t audioPeak = AUDIO_NOISE_FLOOR;
+AudioStep audioStep = eAudioIdle;
+uint8_t audioLevels[AUDIO_BANDS] = {};
+
+inline int16_t audioSin(int k)
+{
+    return (int16_t)pgm_read_word(&audioSine[k & (AUDIO_FFT_SIZE - 1)]);
+}
+
+inline int16_t audioCos(int k)
+{
+    return audioSin(k + AUDIO_FFT_SIZE / 4);
+}
+
+void audioReset()
+{
+    audioRingHead = 0;
+    audioNewSamples = 0;
+    audioPeak = AUDIO_NOISE_FLOOR;
+    audioStep = eAudioIdle;
+    for (int i = 0; i < AUDIO_BANDS; i++)
+    {
+        audioLevels[i] = 0;
+    }
+}
+
+void audioPushSample(uint16_t sample)
+{
+    audioRing[audioRingHead] = sample;
+    audioRingHead = (audioRingHead + 1) & (AUDIO_RING_SIZE - 1);
+    if (audioNewSamples < AUDIO_FFT_SIZE)
+    {
+        audioNewSamples++;
+    }
+}
+
+void audioGap()
+{
+    // Samples were missed, a window must not span the gap. Drop a window that is waiting to be copied and start
+    // collecting a fresh one, a window that was already copied is still contiguous
+    audioNewSamples = 0;
+    if (audioStep == eAudioWindow)
+    {
+        audioStep = eAudioIdle;
+    }
+}
+
+void audioWindow()
+{
+    // Latest AUDIO_FFT_SIZE samples with the DC removed and a Hann window, stored in bit reversed order
+    uint8_t start = (audioRingHead - AUDIO_FFT_SIZE) & (AUDIO_RING_SIZE - 1);
+    int32_t sum = 0;
+    for (int i = 0; i < AUDIO_FFT_SIZE; i++)
+    {
+        sum += audioRing[(start + i) & (AUDIO_RING_SIZE - 1)];
+    }
+    int16_t mean = sum / AUDIO_FFT_SIZE;
+    for (int i = 0; i < AUDIO_FFT_SIZE; i++)
+    {
+        int32_t sample = (audioRing[(start + i) & (AUDIO_RING_SIZE - 1)] - mean) * 32; // 10 bit ADC to about 15 bits
+        int32_t hann = (32767 - audioCos(i)) >> 1;
+        int reversed = 0;
+        for (int bit = 1, r = AUDIO_FFT_SIZE >> 1; bit < AUDIO_FFT_SIZE; bit <<= 1, r >>= 1)
+        {
+            if (i & bit)
+            {
+                reversed |= r;
+            }
+        }
+        audioReal[reversed] = (sample * hann) >> 15;
+        audioImag[reversed] = 0;
+    }
+}
+
+void audioStage(int stage)
+{
+    // Radix-2 butterflies, halving every stage so the fixed point values can't overflow
+    int length = 2 << stage;
+    int half = length / 2;
+    int step = AUDIO_FFT_SIZE / length;
+    for (int start = 0; start < AUDIO_FFT_SIZE; start += length)
+    {
+        for (int j = 0; j < half; j++)
+        {
+            int32_t wr = audioCos(j * step);
+            int32_t wi = -audioSin(j * step);
+            int a = start + j;
+            int b = a + half;
+            int32_t tr = (wr * audioReal[b] - wi * audioImag[b]) >> 15;
+            int32_t ti = (wr * audioImag[b] + wi * audioReal[b]) >> 15;
+            audioReal[b] = (audioReal[a] - tr) >> 1;
+            audioImag[b] = (audioImag[a] - ti) >> 1;
+            audioReal[a] = (audioReal[a] + tr) >> 1;
+            audioImag[a] = (audioImag[a] + ti) >> 1;
+        }
+    }
+}
+
+void audioBands()
+{
+    int32_t energy[AUDIO_BANDS];
+    int32_t loudest = 0;
+    for (int band = 0; band < AUDIO_BANDS; band++)
+    {
+        energy[band] = 0;
+        for (int bin = audioBandBins[band]; bin < audioBandBins[band + 1]; bin++)
+        {
+            // max + min / 2 is close enough to the magnitude and avoids a square root
+            int32_t re = audioReal[bin] < 0 ? -audioReal[bin] : audioReal[bin];
+            int32_t im = audioImag[bin] < 0 ? -audioImag[bin] : audioImag[bin];
+            energy[band] += re > im ? re + im / 2 : im + re / 2;
+        }
+        if (energy[band] > loudest)
+        {
+            loudest = energy[band];
+        }
+    }
+
+    // Automatic gain, follows the loudest band up immediately and slowly back down to the noise floor
+    if (loudest > audioPeak)
+    {
+        audioPeak = loudest;
+    }
+    else
+    {
+        audioPeak -= audioPeak >> 6;
+        if (audioPeak < AUDIO_NOISE_FLOOR)
+        {
+            audioPeak = AUDIO_NOISE_FLOOR;
+        }
+    }
+
+    for (int band = 0; band < AUDIO_BANDS; band++)
+    {
+        int32_t level = energy[band] * 255 / audioPeak;
+        if (level > 255)
+        {
+            level = 255;
+        }
+        int32_t decayed = audioLevels[band] - audioLevels[band] / 8;
+        audioLevels[band] = level > decayed ? level : decayed;
+    }
+}
+
+bool audioProcess()
+{
+    // One slice of the analysis per call, returns true when the band levels have been updated
+    switch (audioStep)
+    {
+    case eAudioIdle:
+        if (audioNewSamples < AUDIO_FFT_SIZE)
+        {
+            return false;
+        }
+        audioNewSamples = 0;
+        audioStep = eAudioWindow;
+        return false;
+    case eAudioWindow:
+        audioWindow();
+        audioStep = eAudioStages01;
+        return false;
+    case eAudioStages01:
+        audioStage(0);
+        audioStage(1);
+        audioStep = eAudioStages23;
+        return false;
+    case eAudioStages23:
+        audioStage(2);
+        audioStage(3);
+        audioStep = eAudioStages45;
+        return false;
+    case eAudioStages45:
+        audioStage(4);
+        audioStage(5);
+        audioStep = eAudioBands;
+        return false;
+    case eAudioBands:
+        audioBands();
+        audioStep = eAudioIdle;
+        return true;
+    }
+    return false;
+}
+
+#define AUDIO_SAMPLE_MICROS (1000000 / AUDIO_SAMPLE_RATE)
+
+unsigned long audioNextSample = 0;
+unsigned long audioDroppedSamples = 0;
+
+void startAudio()
+{
+    audioReset();
+    audioNextSample = micros();
+}
+
+void audioSample()
+{
+    if (effect != eAudio)
+    {
+        return;
+    }
+    unsigned long now = micros();
+    if ((long)(now - audioNextSample) < 0)
+    {
+        return;
+    }
+    if ((long)(now - audioNextSample) >= AUDIO_SAMPLE_MICROS)
+    {
+        // Fell behind (ie. a blocking reconnect), skip the missed samples instead of bunching them up
+        audioDroppedSamples += (now - audioNextSample) / AUDIO_SAMPLE_MICROS;
+        audioNextSample = now;
+        audioGap();
+    }
+    audioPushSample(analogRead(A0));
+    audioNextSample += AUDIO_SAMPLE_MICROS;
+}
+
+void audioLoop()
+{
+    if (effect != eAudio)
+    {
+        return;
+    }
+    audioSample();
+    audioProcess();
+}
+
+void audio()
+{
+    // Each band lights its own segment of the strip, from red for the lows to blue for the highs
+    for (int band = 0; band < AUDIO_BANDS; band++)
+    {
+        uint8_t angle = band * 170 / (AUDIO_BANDS - 1);
+        uint8_t level = audioLevels[band];
+        LedColor color = makeColor(pgm_read_byte(&colorLoopWave[(uint8_t)(angle + 85)]) * level >> 8,
+                                   pgm_read_byte(&colorLoopWave[angle]) * level >> 8,
+                                   pgm_read_byte(&colorLoopWave[(uint8_t)(angle + 171)]) * level >> 8,
+                                   0);
+        for (int i = band * NUM_LEDS / AUDIO_BANDS; i < (band + 1) * NUM_LEDS / AUDIO_BANDS; i++)
+        {
+            stripLeds[i] = color;
+        }
+    }
+}
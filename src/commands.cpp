@@ -0,0 +1,379 @@
+///////////////////////////////////////////////////////////////////////////
+// Light state and the MQTT command handling. Published messages go      //
+// through mqttPublish() so that this runs without a network on the host //
+///////////////////////////////////////////////////////////////////////////
+
+#include <Arduino.h>
+#include <string.h>
+
+#include "common.h"
+
+// Globals
+LedColor stripLeds[NUM_LEDS] = {};
+LedColor customLeds[NUM_LEDS] = {};
+byte enabledLeds[NUM_LEDS / 8 + 1] = {};
+Effect effect = eStable;
+uint8_t red = 0;
+uint8_t green = 0;
+uint8_t blue = 0;
+uint8_t white = 0;
+char gradientMode = 'E';
+int gradientExtent = 50;
+int sunriseDuration = NUM_LEDS;
+uint16_t colorLoopSpeed = 18;   // 1/256ths of a table step per frame, one cycle in ~36 seconds
+uint16_t colorLoopSpread = 182; // 1/256ths of a table step between adjacent leds, ~1 degree
+uint8_t colorLoopSaturation = 255;
+bool on = true;
+char effectStr[64] = "stable";
+// The colorX are pure color, without brightness applied
+uint8_t colorRed = 0;
+uint8_t colorGreen = 0;
+uint8_t colorBlue = 0;
+uint8_t brightness = 0;
+int transition = 1;
+int transitionCounter = 0;
+unsigned long messageCount = 0;
+unsigned long messageMicros = 0;
+unsigned long maxMessageMicros = 0;
+
+// Locals
+char charPayload[MQTT_MAX_PACKET_SIZE];
+int transitionTimerID = -1;
+
+int char2int(char input)
+{
+    if (input >= '0' && input <= '9')
+    {
+        return input - '0';
+    }
+    if (input >= 'A' && input <= 'F')
+    {
+        return input - 'A' + 10;
+    }
+    if (input >= 'a' && input <= 'f')
+    {
+        return input - 'a' + 10;
+    }
+    return 0;
+}
+
+void formatAttributes(char *buf, size_t size)
+{
+    snprintf(buf, size,
+             "{\"mcu_name\":\"" USER_MQTT_CLIENT_NAME "\","
+             "\"num_leds\":%d,"
+             "\"gradient_mode\":\"%c\","
+             "\"gradient_extent\":%d,"
+             "\"colorloop_speed\":%u,"
+             "\"colorloop_spread\":%u,"
+             "\"colorloop_saturation\":%u}",
+             NUM_LEDS, gradientMode, gradientExtent, colorLoopSpeed, colorLoopSpread, colorLoopSaturation);
+}
+
+void publishAttrChange()
+{
+    char buf[256];
+    formatAttributes(buf, sizeof(buf));
+    mqttPublish(USER_MQTT_CLIENT_NAME "/attributes", buf, true);
+}
+
+void publishStateChange()
+{
+    char buf[256];
+    snprintf(buf, 256, "%s,%d,%d,%d,%d,%d,%d,%s", (on ? "on" : "off"), transition, colorRed, colorGreen, colorBlue, white, brightness, effectStr);
+    mqttPublish(USER_MQTT_CLIENT_NAME "/state", buf, true);
+}
+
+void rgbwChange()
+{
+    red = map(colorRed, 0, 255, 0, brightness);
+    green = map(colorGreen, 0, 255, 0, brightness);
+    blue = map(colorBlue, 0, 255, 0, brightness);
+    switch (effect)
+    {
+    case eCustom:
+    case eSunrise:
+    case eColorLoop:
+    case eAudio:
+        // Setting the color or white value should stop effects that don't use the configured color
+        effect = eStable;
+        break;
+    default:
+        break;
+    }
+    startEffect(effect);
+}
+
+void processTransition()
+{
+    int transitionStep = 1;
+    if (transition <= 1)
+    {
+        transitionStep = 2; // one second transition is too short for full 256 steps
+    }
+    transitionCounter -= transitionStep;
+    if (transitionCounter > 0)
+    {
+        transitionTimerID = timer.setTimeout(transition * 1000 / transitionStep / 255, processTransition);
+    }
+    else if (!on)
+    {
+        stopEffect(); // Stop the effect when transition is finished and the new state is off
+    }
+}
+
+void startTransition()
+{
+    if (transitionTimerID != -1)
+    {
+        timer.deleteTimer(transitionTimerID);
+    }
+    transitionTimerID = -1;
+    processTransition();
+}
+
+void handleCommand(const char *payload)
+{
+    bool onOffTransition = false;
+    transition = 1;
+    char *token, *strPtr, *str;
+    strPtr = str = strdup(payload);
+    for (int i = 0; (token = strsep(&str, ",")); i++)
+    {
+        if (!*token)
+        {
+            continue;
+        }
+        switch (i)
+        {
+        case 0: // on/off
+            if (strcmp(token, "on") == 0)
+            {
+                if (!on)
+                {
+                    onOffTransition = true;
+                }
+                on = true;
+            }
+            else if (strcmp(token, "off") == 0)
+            {
+                if (on)
+                {
+                    onOffTransition = true;
+                }
+                on = false;
+            }
+            break;
+        case 1: // transition
+            transition = atoi(token);
+            break;
+        case 2: // r
+            colorRed = atoi(token);
+            rgbwChange();
+            break;
+        case 3: // g
+            colorGreen = atoi(token);
+            rgbwChange();
+            break;
+        case 4: // b
+            colorBlue = atoi(token);
+            rgbwChange();
+            break;
+        case 5: // w
+            white = atoi(token);
+            rgbwChange();
+            break;
+        case 6: // brightness
+            brightness = atoi(token);
+            rgbwChange();
+            break;
+        case 7: // effect
+            if (strcmp(token, "stable") == 0)
+            {
+                startEffect(eStable);
+            }
+            else if (strcmp(token, "colorloop") == 0)
+            {
+                startEffect(eColorLoop);
+            }
+            else if (strcmp(token, "gradient") == 0)
+            {
+                startEffect(eGradient);
+            }
+            else if (strcmp(token, "custom") == 0)
+            {
+                startEffect(eCustom);
+            }
+            else if (strcmp(token, "sunrise") == 0)
+            {
+                startEffect(eSunrise);
+            }
+            else if (strcmp(token, "audio") == 0)
+            {
+                startEffect(eAudio);
+            }
+            else
+            {
+                Serial.print("Unknown effect: ");
+                Serial.println(token);
+                continue;
+            }
+            strcpy(effectStr, token);
+            break;
+        }
+    }
+    free(strPtr);
+    if (onOffTransition)
+    {
+        transitionCounter = transition != 0 ? 256 : 0;
+    }
+    startEffect(effect);
+    publishStateChange();
+    startTransition();
+}
+
+void handleWakeAlarm(int duration)
+{
+    on = true;
+    sunriseDuration = duration;
+    startEffect(eSunrise);
+    publishStateChange();
+}
+
+bool handleSetGradient(const char *payload)
+{
+    if (strlen(payload) < 3)
+    {
+        return false;
+    }
+    char mode = payload[0];
+    switch (mode)
+    {
+    case 'N':
+    case 'F':
+    case 'C':
+    case 'E':
+        gradientMode = mode;
+        gradientExtent = atoi(payload + 2);
+        break;
+    default:
+        return false;
+    }
+    startEffect(eGradient);
+    publishStateChange();
+    publishAttrChange();
+    return true;
+}
+
+bool handleSetColorLoop(const char *payload)
+{
+    unsigned int speed, spread, saturation;
+    if (sscanf(payload, "%u %u %u", &speed, &spread, &saturation) != 3 || speed > 0xffff || spread > 0xffff || saturation > 255)
+    {
+        return false;
+    }
+    colorLoopSpeed = speed;
+    colorLoopSpread = spread;
+    colorLoopSaturation = saturation;
+    // Only the table changes, the running loop carries on from its current phase
+    buildColorLoopTable();
+    publishAttrChange();
+    return true;
+}
+
+void handleSetCustom(const char *payload)
+{
+    const int digits = PixelFormat<LedColor>::Channels * 2; // hex digits per led
+    for (int i = 0; i < NUM_LEDS; i++)
+    {
+        customLeds[i] = LedColor(0);
+    }
+    for (int i = 0; payload[i] && i / digits < NUM_LEDS; i++)
+    {
+        int value;
+        if (i % 2)
+        {
+            value = char2int(payload[i]);
+        }
+        else
+        {
+            value = char2int(payload[i]) << 4;
+        }
+        PixelFormat<LedColor>::channel(customLeds[i / digits], i / 2 % PixelFormat<LedColor>::Channels) |= value;
+    }
+    startEffect(eCustom);
+    publishStateChange();
+    // TODO: add this to attributes and publishAttrChange();
+}
+
+void handleSetEnabledLeds(const char *payload)
+{
+    memset(&enabledLeds, 0, sizeof(enabledLeds));
+    for (int i = 0; payload[i] && i / 2 < static_cast<int>(sizeof(enabledLeds)); i++)
+    {
+        if (i % 2)
+        {
+            enabledLeds[i / 2] |= char2int(payload[i]);
+        }
+        else
+        {
+            enabledLeds[i / 2] = char2int(payload[i]) << 4;
+        }
+    }
+    // TODO: add this to attributes and publishAttrChange();
+}
+
+void callback(char *topic, byte *payload, unsigned int length)
+{
+    unsigned long messageStart = micros();
+    messageCount++;
+    // Leave room for the terminator, longer payloads are truncated
+    unsigned int payloadLength = min(static_cast<unsigned int>(sizeof(charPayload) - 1), length);
+    memcpy(charPayload, payload, payloadLength);
+    charPayload[payloadLength] = '\0';
+    Serial.print("Message arrived [");
+    Serial.print(topic);
+    Serial.print("] ");
+    Serial.println(charPayload);
+
+    if (strcmp(topic, USER_MQTT_CLIENT_NAME "/command") == 0)
+    {
+        handleCommand(charPayload);
+    }
+    else if (strcmp(topic, USER_MQTT_CLIENT_NAME "/wakeAlarm") == 0)
+    {
+        handleWakeAlarm(atoi(charPayload));
+    }
+    else if (strcmp(topic, USER_MQTT_CLIENT_NAME "/setGradient") == 0)
+    {
+        if (!handleSetGradient(charPayload))
+        {
+            Serial.print("Invalid gradient: ");
+            Serial.println(charPayload);
+        }
+    }
+    else if (strcmp(topic, USER_MQTT_CLIENT_NAME "/setColorLoop") == 0)
+    {
+        if (!handleSetColorLoop(charPayload))
+        {
+            Serial.print("Invalid colorloop: ");
+            Serial.println(charPayload);
+        }
+    }
+    else if (strcmp(topic, USER_MQTT_CLIENT_NAME "/setCustom") == 0)
+    {
+        handleSetCustom(charPayload);
+    }
+    else if (strcmp(topic, USER_MQTT_CLIENT_NAME "/setEnabledLeds") == 0)
+    {
+        handleSetEnabledLeds(charPayload);
+    }
+    else if (strcmp(topic, USER_MQTT_CLIENT_NAME "/state") == 0)
+    {
+        // restore previous state after a reboot
+        mqttPublish(USER_MQTT_CLIENT_NAME "/command", charPayload, false);
+        mqttUnsubscribe(USER_MQTT_CLIENT_NAME "/state");
+    }
+    messageMicros = micros() - messageStart;
+    maxMessageMicros = max(maxMessageMicros, messageMicros);
+}
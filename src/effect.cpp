@@ -4,10 +4,28 @@
 
 #include "common.h"
 
-long long effectCounter = 0;
 int effectTimerID = -1;
 
-const uint8_t lights[360] = {0, 0, 0, 0, 0, 1, 1, 2, 2, 3, 4, 5, 6, 7, 8, 9, 11, 12, 13, 15, 17, 18, 20, 22, 24, 26, 28, 30, 32, 35, 37, 39, 42, 44, 47, 49, 52, 55, 58, 60, 63, 66, 69, 72, 75, 78, 81, 85, 88, 91, 94, 97, 101, 104, 107, 111, 114, 117, 121, 124, 127, 131, 134, 137, 141, 144, 147, 150, 154, 157, 160, 163, 167, 170, 173, 176, 179, 182, 185, 188, 191, 194, 197, 200, 202, 205, 208, 210, 213, 215, 217, 220, 222, 224, 226, 229, 231, 232, 234, 236, 238, 239, 241, 242, 244, 245, 246, 248, 249, 250, 251, 251, 252, 253, 253, 254, 254, 255, 255, 255, 255, 255, 255, 255, 254, 254, 253, 253, 252, 251, 251, 250, 249, 248, 246, 245, 244, 242, 241, 239, 238, 236, 234, 232, 231, 229, 226, 224, 222, 220, 217, 215, 213, 210, 208, 205, 202, 200, 197, 194, 191, 188, 185, 182, 179, 176, 173, 170, 167, 163, 160, 157, 154, 150, 147, 144, 141, 137, 134, 131, 127, 124, 121, 117, 114, 111, 107, 104, 101, 97, 94, 91, 88, 85, 81, 78, 75, 72, 69, 66, 63, 60, 58, 55, 52, 49, 47, 44, 42, 39, 37, 35, 32, 30, 28, 26, 24, 22, 20, 18, 17, 15, 13, 12, 11, 9, 8, 7, 6, 5, 4, 3, 2, 2, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+// One hue channel over a full colorloop cycle, the other two channels are the same wave phase shifted by a third
+const uint8_t colorLoopWave[256] PROGMEM = {
+    0, 0, 0, 1, 1, 2, 3, 4, 5, 7, 9, 10, 12, 14, 17, 19,
+    21, 24, 27, 30, 33, 36, 40, 43, 47, 50, 54, 58, 62, 66, 70, 74,
+    79, 83, 88, 92, 97, 101, 106, 110, 115, 120, 124, 129, 134, 138, 143, 148,
+    152, 157, 162, 166, 170, 175, 179, 183, 188, 192, 196, 200, 203, 207, 211, 214,
+    218, 221, 224, 227, 230, 233, 235, 238, 240, 242, 244, 246, 248, 249, 250, 252,
+    253, 253, 254, 255, 255, 255, 255, 255, 254, 254, 253, 252, 251, 250, 249, 247,
+    245, 243, 241, 239, 237, 234, 232, 229, 226, 223, 220, 217, 213, 210, 206, 202,
+    198, 194, 190, 186, 182, 178, 173, 169, 165, 160, 155, 151, 146, 142, 137, 132,
+    128, 123, 118, 113, 109, 104, 100, 95, 90, 86, 82, 77, 73, 69, 65, 61,
+    57, 53, 49, 45, 42, 38, 35, 32, 29, 26, 23, 21, 18, 16, 14, 12,
+    10, 8, 6, 5, 4, 3, 2, 1, 1, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+uint8_t colorLoopTable[256];
+uint16_t colorLoopPhase = 0;
 
 void gradient()
 {
@@ -19,7 +37,7 @@ void gradient()
         for (int i = 0; i < NUM_LEDS; i++)
         {
             x = max(x - stepSize, 0.f);
-            stripLeds[i] = RgbwColor(red * x, green * x, blue * x, white * x);
+            stripLeds[i] = makeColor(red * x, green * x, blue * x, white * x);
         }
         break;
     case 'F':
@@ -27,7 +45,7 @@ void gradient()
         for (int i = NUM_LEDS - 1; i >= 0; i--)
         {
             x = max(x - stepSize, 0.f);
-            stripLeds[i] = RgbwColor(red * x, green * x, blue * x, white * x);
+            stripLeds[i] = makeColor(red * x, green * x, blue * x, white * x);
         }
         break;
         break;
@@ -36,13 +54,13 @@ void gradient()
         for (int i = NUM_LEDS / 2; i < NUM_LEDS; i++)
         {
             x = max(x - stepSize, 0.f);
-            stripLeds[i] = RgbwColor(red * x, green * x, blue * x, white * x);
+            stripLeds[i] = makeColor(red * x, green * x, blue * x, white * x);
         }
         x = 1.f;
         for (int i = NUM_LEDS / 2 - 1; i >= 0; i--)
         {
             x = max(x - stepSize, 0.f);
-            stripLeds[i] = RgbwColor(red * x, green * x, blue * x, white * x);
+            stripLeds[i] = makeColor(red * x, green * x, blue * x, white * x);
         }
         break;
     case 'E':
@@ -50,18 +68,40 @@ void gradient()
         for (int i = 0; i < NUM_LEDS / 2; i++)
         {
             x = max(x - stepSize, 0.f);
-            stripLeds[i] = RgbwColor(red * x, green * x, blue * x, white * x);
+            stripLeds[i] = makeColor(red * x, green * x, blue * x, white * x);
         }
         x = 1.f;
         for (int i = NUM_LEDS - 1; i >= NUM_LEDS / 2; i--)
         {
             x = max(x - stepSize, 0.f);
-            stripLeds[i] = RgbwColor(red * x, green * x, blue * x, white * x);
+            stripLeds[i] = makeColor(red * x, green * x, blue * x, white * x);
         }
         break;
     }
 }
 
+void buildColorLoopTable()
+{
+    // Saturation is baked into the table once per effect start so that the per pixel work is just three lookups
+    for (int i = 0; i < 256; i++)
+    {
+        uint8_t value = pgm_read_byte(&colorLoopWave[i]);
+        colorLoopTable[i] = value + ((255 - value) * (255 - colorLoopSaturation) >> 8);
+    }
+}
+
+void colorLoop()
+{
+    // 8.8 fixed point phase, the high byte wraps around the table for free
+    uint16_t phase = colorLoopPhase;
+    for (int i = 0; i < NUM_LEDS; i++)
+    {
+        uint8_t angle = phase >> 8;
+        stripLeds[i] = makeColor(colorLoopTable[(uint8_t)(angle + 85)], colorLoopTable[angle], colorLoopTable[(uint8_t)(angle + 171)], 0);
+        phase += colorLoopSpread;
+    }
+}
+
 void runEffect()
 {
     switch (effect)
@@ -69,7 +109,7 @@ void runEffect()
     case eStable:
         for (int i = 0; i < NUM_LEDS; i++)
         {
-            stripLeds[i] = RgbwColor(red, green, blue, white);
+            stripLeds[i] = makeColor(red, green, blue, white);
         }
         break;
     case eGradient:
@@ -86,13 +126,13 @@ void runEffect()
         sunrise();
         break;
     case eColorLoop:
-        effectCounter++;
+        colorLoopPhase += colorLoopSpeed;
         effectTimerID = timer.setTimeout(10, runEffect);
-        for (int i = 0; i < NUM_LEDS; i++)
-        {
-            int angle = (effectCounter / 10 + i) % 360;
-            stripLeds[i] = RgbwColor(lights[(angle + 120) % 360], lights[angle], lights[(angle + 240) % 360], 0);
-        }
+        colorLoop();
+        break;
+    case eAudio:
+        effectTimerID = timer.setTimeout(10, runEffect);
+        audio();
         break;
     default:
         Serial.println("Unknown effect?");
@@ -103,7 +143,15 @@ void startEffect(Effect e)
 {
     stopEffect();
     effect = e;
-    effectCounter = 0;
+    if (effect == eColorLoop)
+    {
+        colorLoopPhase = 0;
+        buildColorLoopTable();
+    }
+    if (effect == eAudio)
+    {
+        startAudio();
+    }
     if (effect == eSunrise)
     {
         // Sunrise is its own self-contained spaghetti with its own timers that need to be started as well
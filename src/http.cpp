@@ -0,0 +1,205 @@
+/////////////////////////////////////////////////////////////////
+// HTTP control API, served next to the OTA update page. Uses  //
+// the same handlers as the MQTT topics                        //
+/////////////////////////////////////////////////////////////////
+
+#include "common.h"
+
+#if defined(HTTPUpdateServer) && defined(HTTPApi)
+#include <ESP8266WebServer.h>
+
+extern ESP8266WebServer httpUpdateServer;
+
+bool customUploadAuthorized = false;
+
+bool checkHttpAuth()
+{
+    if (!httpUpdateServer.authenticate(USER_HTTP_USERNAME, USER_HTTP_PASSWORD))
+    {
+        httpUpdateServer.requestAuthentication();
+        return false;
+    }
+    return true;
+}
+
+void httpGetState()
+{
+    char buf[256];
+    snprintf(buf, 256,
+             "{\"state\":\"%s\","
+             "\"transition\":%d,"
+             "\"red\":%d,"
+             "\"green\":%d,"
+             "\"blue\":%d,"
+             "\"white\":%d,"
+             "\"brightness\":%d,"
+             "\"effect\":\"%s\"}",
+             (on ? "on" : "off"), transition, colorRed, colorGreen, colorBlue, white, brightness, effectStr);
+    httpUpdateServer.send(200, "application/json", buf);
+}
+
+void httpPutState()
+{
+    if (!checkHttpAuth())
+    {
+        return;
+    }
+    // Same comma separated format as the command topic
+    handleCommand(httpUpdateServer.arg("plain").c_str());
+    httpGetState();
+}
+
+void httpGetEffect()
+{
+    char buf[256];
+    formatAttributes(buf, sizeof(buf));
+    httpUpdateServer.send(200, "application/json", buf);
+}
+
+void httpPutGradient()
+{
+    if (!checkHttpAuth())
+    {
+        return;
+    }
+    if (!handleSetGradient(httpUpdateServer.arg("plain").c_str()))
+    {
+        httpUpdateServer.send(400, "text/plain", "Invalid gradient\n");
+        return;
+    }
+    httpGetEffect();
+}
+
+void httpPutColorLoop()
+{
+    if (!checkHttpAuth())
+    {
+        return;
+    }
+    if (!handleSetColorLoop(httpUpdateServer.arg("plain").c_str()))
+    {
+        httpUpdateServer.send(400, "text/plain", "Invalid colorloop\n");
+        return;
+    }
+    httpGetEffect();
+}
+
+void httpCustomUpload()
+{
+    // The body is raw RGB(W) bytes streamed straight into the custom frame, so NUL bytes survive and no copy of the body is kept
+    HTTPRaw &raw = httpUpdateServer.raw();
+    if (raw.status == RAW_START)
+    {
+        customUploadAuthorized = httpUpdateServer.authenticate(USER_HTTP_USERNAME, USER_HTTP_PASSWORD);
+        if (customUploadAuthorized)
+        {
+            memset(&customLeds, 0, sizeof(customLeds));
+        }
+    }
+    else if (raw.status == RAW_WRITE && customUploadAuthorized)
+    {
+        size_t offset = raw.totalSize - raw.currentSize;
+        if (offset < sizeof(customLeds))
+        {
+            memcpy(reinterpret_cast<uint8_t *>(customLeds) + offset, raw.buf, min(raw.currentSize, sizeof(customLeds) - offset));
+        }
+    }
+    else if (raw.status == RAW_ABORTED && customUploadAuthorized)
+    {
+        // The client went away mid upload and httpPutCustom() won't run, don't leave half a frame behind
+        memset(&customLeds, 0, sizeof(customLeds));
+        customUploadAuthorized = false;
+    }
+}
+
+void httpPutCustom()
+{
+    if (!checkHttpAuth())
+    {
+        customUploadAuthorized = false;
+        return;
+    }
+    if (!customUploadAuthorized)
+    {
+        // An empty body never reaches the upload handler, it still clears the frame
+        memset(&customLeds, 0, sizeof(customLeds));
+    }
+    customUploadAuthorized = false;
+    startEffect(eCustom);
+    publishStateChange();
+    httpUpdateServer.send(204);
+}
+
+void httpGetMetrics()
+{
+    char buf[320];
+    snprintf(buf, sizeof(buf),
+             "{\"uptime_ms\":%lu,"
+             "\"free_heap\":%u,"
+             "\"frames\":%lu,"
+             "\"frame_us\":%lu,"
+             "\"max_frame_us\":%lu,"
+             "\"http_us\":%lu,"
+             "\"max_http_us\":%lu,"
+             "\"mqtt_messages\":%lu,"
+             "\"message_us\":%lu,"
+             "\"max_message_us\":%lu,"
+             "\"audio_dropped_samples\":%lu}",
+             millis(), ESP.getFreeHeap(), frameCount, frameMicros, maxFrameMicros, httpMicros, maxHttpMicros, messageCount, messageMicros, maxMessageMicros, audioDroppedSamples);
+    httpUpdateServer.send(200, "application/json", buf);
+}
+
+void httpSendFrame(LedColor (*getPixel)(int))
+{
+    // One byte per channel in RGB(W) order, the same format as PUT /api/custom.
+    // Sent in small chunks so that long strips don't need the whole frame on the stack.
+    const int channels = PixelFormat<LedColor>::Channels;
+    const int chunkLeds = 32;
+    uint8_t chunk[chunkLeds * channels];
+    httpUpdateServer.setContentLength(NUM_LEDS * channels);
+    httpUpdateServer.send(200, "application/octet-stream", "");
+    for (int start = 0; start < NUM_LEDS; start += chunkLeds)
+    {
+        int count = min(chunkLeds, NUM_LEDS - start);
+        for (int i = 0; i < count; i++)
+        {
+            LedColor color = getPixel(start + i);
+            for (int c = 0; c < channels; c++)
+            {
+                chunk[i * channels + c] = PixelFormat<LedColor>::channel(color, c);
+            }
+        }
+        httpUpdateServer.sendContent(reinterpret_cast<const char *>(chunk), count * channels);
+    }
+}
+
+LedColor getCustomPixel(int i)
+{
+    return customLeds[i];
+}
+
+void httpGetCustom()
+{
+    // The custom mode frame as uploaded, before brightness and enabled leds are applied
+    httpSendFrame(getCustomPixel);
+}
+
+void httpGetPreview()
+{
+    // The composited frame as last sent to the strip
+    httpSendFrame(getOutputPixel);
+}
+
+void setupHttpApi()
+{
+    httpUpdateServer.on("/api/state", HTTP_GET, httpGetState);
+    httpUpdateServer.on("/api/state", HTTP_PUT, httpPutState);
+    httpUpdateServer.on("/api/effect", HTTP_GET, httpGetEffect);
+    httpUpdateServer.on("/api/effect/gradient", HTTP_PUT, httpPutGradient);
+    httpUpdateServer.on("/api/effect/colorloop", HTTP_PUT, httpPutColorLoop);
+    httpUpdateServer.on("/api/custom", HTTP_GET, httpGetCustom);
+    httpUpdateServer.on("/api/custom", HTTP_PUT, httpPutCustom, httpCustomUpload);
+    httpUpdateServer.on("/api/metrics", HTTP_GET, httpGetMetrics);
+    httpUpdateServer.on("/api/preview", HTTP_GET, httpGetPreview);
+}
+#endif
@@ -0,0 +1,133 @@
+//////////////////////////////////////////////////////////////////
+// Output channels, several strips driven as one logical strip //
+//////////////////////////////////////////////////////////////////
+
+#include "common.h"
+
+#ifndef CHANNEL0_LEDS
+// The original single strip setup, DMA on GPIO3 (RX)
+#define CHANNEL0_LEDS NUM_LEDS
+#ifdef PIXEL_FORMAT_RGB
+#define CHANNEL0_FEATURE NeoGrbFeature
+#else
+#define CHANNEL0_FEATURE NeoGrbwFeature
+#endif
+#define CHANNEL0_METHOD Neo800KbpsMethod
+#endif
+#ifndef CHANNEL1_LEDS
+#define CHANNEL1_LEDS 0
+#endif
+#ifndef CHANNEL2_LEDS
+#define CHANNEL2_LEDS 0
+#endif
+
+#define CHANNEL1_START (CHANNEL0_LEDS)
+#define CHANNEL2_START (CHANNEL0_LEDS + CHANNEL1_LEDS)
+
+static_assert(CHANNEL0_LEDS + CHANNEL1_LEDS + CHANNEL2_LEDS == NUM_LEDS, "The channel lengths must add up to NUM_LEDS");
+
+template <typename T_FEATURE, typename T_METHOD>
+inline void setChannelPixel(NeoPixelBus<T_FEATURE, T_METHOD> &channel, uint16_t i, const LedColor &color)
+{
+    typename T_FEATURE::ColorObject channelColor;
+    convertColor(color, channelColor);
+    channel.SetPixelColor(i, channelColor);
+}
+
+template <typename T_FEATURE, typename T_METHOD>
+inline LedColor getChannelPixel(NeoPixelBus<T_FEATURE, T_METHOD> &channel, uint16_t i)
+{
+    LedColor color;
+    convertColor(channel.GetPixelColor(i), color);
+    return color;
+}
+
+template <typename T_FEATURE, typename T_METHOD>
+inline void showChannel(NeoPixelBus<T_FEATURE, T_METHOD> &channel, bool &pending)
+{
+    if (pending && channel.CanShow())
+    {
+        channel.Show();
+        pending = false;
+    }
+}
+
+NeoPixelBus<CHANNEL0_FEATURE, CHANNEL0_METHOD> channel0(CHANNEL0_LEDS);
+#if CHANNEL1_LEDS > 0
+NeoPixelBus<CHANNEL1_FEATURE, CHANNEL1_METHOD> channel1(CHANNEL1_LEDS);
+#endif
+#if CHANNEL2_LEDS > 0
+NeoPixelBus<CHANNEL2_FEATURE, CHANNEL2_METHOD> channel2(CHANNEL2_LEDS);
+#endif
+
+void setupOutputs()
+{
+    channel0.Begin();
+#if CHANNEL1_LEDS > 0
+    channel1.Begin();
+#endif
+#if CHANNEL2_LEDS > 0
+    channel2.Begin();
+#endif
+    showOutputs();
+}
+
+void setOutputPixel(int i, const LedColor &color)
+{
+#if CHANNEL2_LEDS > 0
+    if (i >= CHANNEL2_START)
+    {
+        setChannelPixel(channel2, i - CHANNEL2_START, color);
+        return;
+    }
+#endif
+#if CHANNEL1_LEDS > 0
+    if (i >= CHANNEL1_START)
+    {
+        setChannelPixel(channel1, i - CHANNEL1_START, color);
+        return;
+    }
+#endif
+    setChannelPixel(channel0, i, color);
+}
+
+LedColor getOutputPixel(int i)
+{
+#if CHANNEL2_LEDS > 0
+    if (i >= CHANNEL2_START)
+    {
+        return getChannelPixel(channel2, i - CHANNEL2_START);
+    }
+#endif
+#if CHANNEL1_LEDS > 0
+    if (i >= CHANNEL1_START)
+    {
+        return getChannelPixel(channel1, i - CHANNEL1_START);
+    }
+#endif
+    return getChannelPixel(channel0, i);
+}
+
+void showOutputs()
+{
+    // Start each channel as soon as it has finished sending its previous frame instead of waiting for them in order.
+    // With DMA and async UART methods Show() returns right away, so the channels end up transmitting in parallel.
+    bool pending0 = true;
+    bool pending1 = CHANNEL1_LEDS > 0;
+    bool pending2 = CHANNEL2_LEDS > 0;
+    while (pending0 || pending1 || pending2)
+    {
+        showChannel(channel0, pending0);
+#if CHANNEL1_LEDS > 0
+        showChannel(channel1, pending1);
+#endif
+#if CHANNEL2_LEDS > 0
+        showChannel(channel2, pending2);
+#endif
+        if (pending0 || pending1 || pending2)
+        {
+            audioSample(); // keep the audio sample rate up while waiting for the strip
+            yield();
+        }
+    }
+}
@@ -66,12 +66,12 @@ void increaseWhiteLevel()
 
 void drawAurora(int sunLeft, int SunRight)
 {
-    RgbwColor color = RgbwColor(1, 0, 0, 0);
+    LedColor color = makeColor(1, 0, 0, 0);
     for (int i = 0; i < sunLeft; i++)
     {
         stripLeds[i] = color;
     }
-    for (int i = SunRight + 1; i <= NUM_LEDS; i++)
+    for (int i = SunRight + 1; i < NUM_LEDS; i++)
     {
         stripLeds[i] = color;
     }
@@ -97,17 +97,17 @@ void drawSun()
         maxRed = 0;
     }
     int maxGreen = map(sunPhase, 0, 256, 64, 0);
-    if (newSunLeft >= 0 && newSunRight <= NUM_LEDS && sunPhase > 0)
+    if (newSunLeft >= 0 && newSunRight < NUM_LEDS && sunPhase > 0)
     {
         int redValue = map(sunFadeStep, 0, 256, 1, maxRed);
         int greenValue = map(sunFadeStep, 0, 256, 0, maxGreen);
         int whiteValue = map(sunFadeStep, 0, 256, 0, whiteLevel);
-        stripLeds[newSunLeft] = RgbwColor(redValue, greenValue, 0, whiteValue);
-        stripLeds[newSunRight] = RgbwColor(redValue, greenValue, 0, whiteValue);
+        stripLeds[newSunLeft] = makeColor(redValue, greenValue, 0, whiteValue);
+        stripLeds[newSunRight] = makeColor(redValue, greenValue, 0, whiteValue);
     }
     drawAurora(newSunLeft, newSunRight);
 
-    RgbwColor color = RgbwColor(maxRed, maxGreen, 0, whiteLevel);
+    LedColor color = makeColor(maxRed, maxGreen, 0, whiteLevel);
     for (int i = sunStart; i < sunStart + currentSun; i++)
     {
         stripLeds[i] = color;
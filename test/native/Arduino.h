@@ -0,0 +1,57 @@
+// Host stand-in for the parts of the Arduino core that the light code uses
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+typedef uint8_t byte;
+
+using std::max;
+using std::min;
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+#define A0 17
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+unsigned long micros();
+unsigned long millis();
+void yield();
+int analogRead(uint8_t pin);
+
+class HardwareSerial
+{
+public:
+    template <typename T>
+    void print(T)
+    {
+    }
+    template <typename T>
+    void println(T)
+    {
+    }
+    void println()
+    {
+    }
+};
+
+class EspClass
+{
+public:
+    uint32_t getFreeHeap()
+    {
+        return 0;
+    }
+};
+
+extern HardwareSerial Serial;
+extern EspClass ESP;
@@ -0,0 +1,175 @@
+// Host stand-in for ESP8266WebServer. Requests are run through the registered handlers the way the real server
+// does it, including streaming non-empty bodies to raw upload handlers in chunks.
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+enum HTTPMethod
+{
+    HTTP_ANY,
+    HTTP_GET,
+    HTTP_HEAD,
+    HTTP_POST,
+    HTTP_PUT,
+    HTTP_PATCH,
+    HTTP_DELETE,
+    HTTP_OPTIONS
+};
+
+enum HTTPRawStatus
+{
+    RAW_START,
+    RAW_WRITE,
+    RAW_END,
+    RAW_ABORTED
+};
+
+#define HTTP_RAW_BUFLEN 1460
+
+struct HTTPRaw
+{
+    HTTPRawStatus status;
+    size_t totalSize;
+    size_t currentSize;
+    uint8_t buf[HTTP_RAW_BUFLEN];
+};
+
+class ESP8266WebServer
+{
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    ESP8266WebServer(int)
+    {
+    }
+
+    void on(const char *uri, HTTPMethod method, THandlerFunction fn)
+    {
+        on(uri, method, fn, nullptr);
+    }
+
+    void on(const char *uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn)
+    {
+        routes.push_back({uri, method, fn, ufn});
+    }
+
+    void begin()
+    {
+    }
+
+    void handleClient()
+    {
+    }
+
+    bool authenticate(const char *username, const char *password)
+    {
+        return requestUsername == username && requestPassword == password;
+    }
+
+    void requestAuthentication()
+    {
+        send(401);
+    }
+
+    const std::string &arg(const char *)
+    {
+        return plain;
+    }
+
+    HTTPRaw &raw()
+    {
+        return currentRaw;
+    }
+
+    void setContentLength(size_t length)
+    {
+        contentLength = length;
+    }
+
+    void send(int code, const char *contentType = "", const char *content = "")
+    {
+        responseCode = code;
+        responseType = contentType;
+        responseBody = content;
+    }
+
+    void sendContent(const char *content, size_t size)
+    {
+        responseBody.append(content, size);
+    }
+
+    // Host only, returns the response code. rawChunkSize splits uploads into smaller chunks than the real server would,
+    // abortAfter drops the connection once that many body bytes have been streamed.
+    int request(HTTPMethod method, const char *uri, const std::string &body, const char *username = "", const char *password = "", size_t rawChunkSize = HTTP_RAW_BUFLEN, size_t abortAfter = SIZE_MAX)
+    {
+        requestUsername = username;
+        requestPassword = password;
+        plain.clear();
+        contentLength = 0;
+        responseCode = 0;
+        responseType.clear();
+        responseBody.clear();
+        for (const Route &route : routes)
+        {
+            if (route.uri != uri || route.method != method)
+            {
+                continue;
+            }
+            if (route.ufn && !body.empty())
+            {
+                currentRaw.status = RAW_START;
+                currentRaw.totalSize = 0;
+                currentRaw.currentSize = 0;
+                route.ufn();
+                currentRaw.status = RAW_WRITE;
+                while (currentRaw.totalSize < body.size())
+                {
+                    if (currentRaw.totalSize >= abortAfter)
+                    {
+                        // Like the real server, the request handler isn't called for an aborted upload
+                        currentRaw.status = RAW_ABORTED;
+                        route.ufn();
+                        return responseCode;
+                    }
+                    currentRaw.currentSize = min(min(rawChunkSize, (size_t)HTTP_RAW_BUFLEN), body.size() - currentRaw.totalSize);
+                    memcpy(currentRaw.buf, body.data() + currentRaw.totalSize, currentRaw.currentSize);
+                    currentRaw.totalSize += currentRaw.currentSize;
+                    route.ufn();
+                }
+                currentRaw.status = RAW_END;
+                route.ufn();
+            }
+            else
+            {
+                plain = body;
+            }
+            route.fn();
+            return responseCode;
+        }
+        send(404);
+        return responseCode;
+    }
+
+    int responseCode = 0;
+    size_t contentLength = 0;
+    std::string responseType;
+    std::string responseBody;
+
+private:
+    struct Route
+    {
+        std::string uri;
+        HTTPMethod method;
+        THandlerFunction fn;
+        THandlerFunction ufn;
+    };
+
+    std::vector<Route> routes;
+    std::string requestUsername;
+    std::string requestPassword;
+    std::string plain;
+    HTTPRaw currentRaw = {};
+};
@@ -0,0 +1,92 @@
+// Host stand-in for NeoPixelBus, the color objects behave like the real ones and the buses only keep their pixels
+#pragma once
+
+#include <Arduino.h>
+#include <vector>
+
+struct RgbColor
+{
+    RgbColor(uint8_t r, uint8_t g, uint8_t b) : R(r), G(g), B(b)
+    {
+    }
+    RgbColor(uint8_t brightness = 0) : R(brightness), G(brightness), B(brightness)
+    {
+    }
+    uint8_t R;
+    uint8_t G;
+    uint8_t B;
+};
+
+struct RgbwColor
+{
+    RgbwColor(uint8_t r, uint8_t g, uint8_t b, uint8_t w = 0) : R(r), G(g), B(b), W(w)
+    {
+    }
+    RgbwColor(uint8_t brightness = 0) : R(0), G(0), B(0), W(brightness)
+    {
+    }
+    RgbwColor(const RgbColor &color) : R(color.R), G(color.G), B(color.B), W(0)
+    {
+    }
+    uint8_t R;
+    uint8_t G;
+    uint8_t B;
+    uint8_t W;
+};
+
+struct NeoGrbFeature
+{
+    typedef RgbColor ColorObject;
+};
+struct NeoRgbFeature
+{
+    typedef RgbColor ColorObject;
+};
+struct NeoGrbwFeature
+{
+    typedef RgbwColor ColorObject;
+};
+struct NeoRgbwFeature
+{
+    typedef RgbwColor ColorObject;
+};
+
+struct Neo800KbpsMethod
+{
+};
+struct NeoEsp8266Dma800KbpsMethod
+{
+};
+struct NeoEsp8266AsyncUart1800KbpsMethod
+{
+};
+
+template <typename T_COLOR_FEATURE, typename T_METHOD>
+class NeoPixelBus
+{
+public:
+    NeoPixelBus(uint16_t countPixels) : _pixels(countPixels)
+    {
+    }
+    void Begin()
+    {
+    }
+    bool CanShow() const
+    {
+        return true;
+    }
+    void Show()
+    {
+    }
+    void SetPixelColor(uint16_t indexPixel, typename T_COLOR_FEATURE::ColorObject color)
+    {
+        _pixels.at(indexPixel) = color;
+    }
+    typename T_COLOR_FEATURE::ColorObject GetPixelColor(uint16_t indexPixel) const
+    {
+        return _pixels.at(indexPixel);
+    }
+
+private:
+    std::vector<typename T_COLOR_FEATURE::ColorObject> _pixels;
+};
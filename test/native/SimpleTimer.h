@@ -0,0 +1,56 @@
+// Host stand-in for SimpleTimer, timeouts only fire when a test asks for it
+#pragma once
+
+#define MAX_TIMERS 10
+
+class SimpleTimer
+{
+public:
+    typedef void (*timer_callback)();
+
+    int setTimeout(long, timer_callback f)
+    {
+        for (int i = 0; i < MAX_TIMERS; i++)
+        {
+            if (!callbacks[i])
+            {
+                callbacks[i] = f;
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void deleteTimer(int numTimer)
+    {
+        if (numTimer >= 0 && numTimer < MAX_TIMERS)
+        {
+            callbacks[numTimer] = nullptr;
+        }
+    }
+
+    void run()
+    {
+    }
+
+    // Fires every timeout that is pending now once, timeouts set by the callbacks wait for the next call
+    void runPending()
+    {
+        timer_callback pending[MAX_TIMERS];
+        for (int i = 0; i < MAX_TIMERS; i++)
+        {
+            pending[i] = callbacks[i];
+            callbacks[i] = nullptr;
+        }
+        for (int i = 0; i < MAX_TIMERS; i++)
+        {
+            if (pending[i])
+            {
+                pending[i]();
+            }
+        }
+    }
+
+private:
+    timer_callback callbacks[MAX_TIMERS] = {};
+};
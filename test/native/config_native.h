@@ -0,0 +1,10 @@
+#define USER_MQTT_CLIENT_NAME "LED_MCU"
+
+#define NUM_LEDS 60 // not a multiple of 8 so the last enabled leds byte is partial
+#define BRIGHTNESS 255
+#define SUNSIZE 30
+
+#define HTTPUpdateServer
+#define USER_HTTP_USERNAME "some_user"
+#define USER_HTTP_PASSWORD "hunter3"
+#define HTTPApi
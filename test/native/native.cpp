@@ -0,0 +1,52 @@
+#include <chrono>
+#include <ESP8266WebServer.h>
+
+#include "common.h"
+#include "native.h"
+
+SimpleTimer timer;
+ESP8266WebServer httpUpdateServer(80);
+HardwareSerial Serial;
+EspClass ESP;
+
+int publishCount = 0;
+char publishedTopic[64] = "";
+char publishedPayload[256] = "";
+bool publishedRetained = false;
+unsigned long frameCount = 0;
+unsigned long frameMicros = 0;
+unsigned long maxFrameMicros = 0;
+unsigned long httpMicros = 0;
+unsigned long maxHttpMicros = 0;
+
+unsigned long micros()
+{
+    static auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned long millis()
+{
+    return micros() / 1000;
+}
+
+void yield()
+{
+}
+
+int analogRead(uint8_t)
+{
+    return 512;
+}
+
+void mqttPublish(const char *topic, const char *payload, bool retained)
+{
+    publishCount++;
+    snprintf(publishedTopic, sizeof(publishedTopic), "%s", topic);
+    snprintf(publishedPayload, sizeof(publishedPayload), "%s", payload);
+    publishedRetained = retained;
+}
+
+void mqttUnsubscribe(const char *)
+{
+}
@@ -0,0 +1,7 @@
+// What main.cpp provides on the MCU, with the published MQTT messages kept for the tests
+#pragma once
+
+extern int publishCount;
+extern char publishedTopic[64];
+extern char publishedPayload[256];
+extern bool publishedRetained;
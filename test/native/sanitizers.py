@@ -0,0 +1,4 @@
+# The sanitizers need the runtime linked in as well, build_flags only reach the compiler
+Import("env")
+
+env.Append(LINKFLAGS=["-fsanitize=address,undefined", "-fno-sanitize-recover=all"])
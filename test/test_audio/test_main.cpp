@@ -0,0 +1,204 @@
+// Feeds a recorded WAV file through the same audio pipeline that the audio effect uses on the MCU
+
+#include <math.h>
+#include <string>
+#include <vector>
+#include <unity.h>
+
+#include "common.h"
+#include "audio.h"
+
+struct Wav
+{
+    uint32_t sampleRate = 0;
+    std::vector<int16_t> samples;
+};
+
+uint32_t readLittleEndian(const uint8_t *bytes, int count)
+{
+    uint32_t value = 0;
+    for (int i = count - 1; i >= 0; i--)
+    {
+        value = value << 8 | bytes[i];
+    }
+    return value;
+}
+
+bool readWav(const char *name, Wav &wav)
+{
+    // 16 bit mono PCM only
+    std::string path = __FILE__;
+    path = path.substr(0, path.find_last_of("/\\") + 1) + name;
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buf[512];
+    size_t read;
+    while ((read = fread(buf, 1, sizeof(buf), file)) > 0)
+    {
+        data.insert(data.end(), buf, buf + read);
+    }
+    fclose(file);
+
+    if (data.size() < 12 || memcmp(&data[0], "RIFF", 4) || memcmp(&data[8], "WAVE", 4))
+    {
+        return false;
+    }
+    bool pcm = false;
+    for (size_t chunk = 12; chunk + 8 <= data.size();)
+    {
+        uint32_t size = readLittleEndian(&data[chunk + 4], 4);
+        if (chunk + 8 + size > data.size())
+        {
+            return false;
+        }
+        const uint8_t *body = &data[chunk + 8];
+        if (!memcmp(&data[chunk], "fmt ", 4) && size >= 16)
+        {
+            pcm = readLittleEndian(body, 2) == 1 && readLittleEndian(body + 2, 2) == 1 && readLittleEndian(body + 14, 2) == 16;
+            wav.sampleRate = readLittleEndian(body + 4, 4);
+        }
+        else if (!memcmp(&data[chunk], "data", 4) && pcm)
+        {
+            for (uint32_t i = 0; i + 1 < size; i += 2)
+            {
+                wav.samples.push_back((int16_t)readLittleEndian(body + i, 2));
+            }
+            return true;
+        }
+        chunk += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+void feed(const Wav &wav, size_t start, size_t end)
+{
+    for (size_t i = start; i < end; i++)
+    {
+        // 16 bit signed to the 10 bit ADC range with the bias of a microphone module
+        audioPushSample((wav.samples[i] >> 6) + 512);
+        audioProcess();
+    }
+}
+
+void pushTone(int count)
+{
+    // 250Hz, loud enough to light its band if it gets analysed
+    static int phase = 0;
+    for (int i = 0; i < count; i++, phase++)
+    {
+        audioPushSample(512 + (int)(400 * sin(2 * M_PI * 250 * phase / AUDIO_SAMPLE_RATE)));
+    }
+}
+
+int loudestBand()
+{
+    int loudest = 0;
+    for (int band = 1; band < AUDIO_BANDS; band++)
+    {
+        if (audioLevels[band] > audioLevels[loudest])
+        {
+            loudest = band;
+        }
+    }
+    return loudest;
+}
+
+void setUp()
+{
+    audioReset();
+}
+
+void tearDown()
+{
+}
+
+void test_recorded_tones()
+{
+    // tones.wav has half a second of 250Hz followed by half a second of 781Hz, with some noise
+    Wav wav;
+    TEST_ASSERT_TRUE_MESSAGE(readWav("tones.wav", wav), "tones.wav");
+    TEST_ASSERT_EQUAL(AUDIO_SAMPLE_RATE, wav.sampleRate);
+    size_t half = wav.samples.size() / 2;
+
+    feed(wav, 0, half);
+    TEST_ASSERT_EQUAL(4, loudestBand()); // 219-281Hz
+    TEST_ASSERT_EQUAL_UINT8(255, audioLevels[4]);
+    TEST_ASSERT_LESS_THAN(64, audioLevels[0]);
+    TEST_ASSERT_LESS_THAN(64, audioLevels[7]);
+
+    feed(wav, half, wav.samples.size());
+    TEST_ASSERT_EQUAL(7, loudestBand()); // 625-969Hz
+    TEST_ASSERT_LESS_THAN(64, audioLevels[4]); // decayed since the first tone
+}
+
+void test_silence()
+{
+    for (int i = 0; i < AUDIO_SAMPLE_RATE; i++)
+    {
+        audioPushSample(512);
+        audioProcess();
+    }
+    for (int band = 0; band < AUDIO_BANDS; band++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(0, audioLevels[band]);
+    }
+}
+
+void test_gap_before_window_copy()
+{
+    // A window is ready but not copied yet when samples are missed, it must not be analysed with the sample after the gap
+    pushTone(AUDIO_FFT_SIZE);
+    TEST_ASSERT_FALSE(audioProcess());
+    audioGap();
+    pushTone(1);
+    for (int i = 0; i < 16; i++)
+    {
+        TEST_ASSERT_FALSE(audioProcess());
+    }
+    for (int band = 0; band < AUDIO_BANDS; band++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(0, audioLevels[band]);
+    }
+
+    // A full window after the gap is analysed again
+    pushTone(AUDIO_FFT_SIZE - 1);
+    bool updated = false;
+    for (int i = 0; i < 16 && !updated; i++)
+    {
+        updated = audioProcess();
+    }
+    TEST_ASSERT_TRUE(updated);
+    TEST_ASSERT_EQUAL(4, loudestBand());
+}
+
+void test_render_follows_levels()
+{
+    // The lowest band lights the start of the strip red, the highest the end blue
+    audioLevels[0] = 255;
+    audioLevels[AUDIO_BANDS - 1] = 255;
+    audio();
+    LedColor low = stripLeds[0];
+    LedColor high = stripLeds[NUM_LEDS - 1];
+    TEST_ASSERT_GREATER_THAN(200, low.R);
+    TEST_ASSERT_LESS_THAN(8, low.B);
+    TEST_ASSERT_GREATER_THAN(200, high.B);
+    TEST_ASSERT_LESS_THAN(8, high.R);
+    LedColor middle = stripLeds[NUM_LEDS / 2];
+    TEST_ASSERT_EQUAL_UINT8(0, middle.R);
+    TEST_ASSERT_EQUAL_UINT8(0, middle.G);
+    TEST_ASSERT_EQUAL_UINT8(0, middle.B);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_recorded_tones);
+    RUN_TEST(test_silence);
+    RUN_TEST(test_gap_before_window_copy);
+    RUN_TEST(test_render_follows_levels);
+    return UNITY_END();
+}
@@ -0,0 +1,197 @@
+// Runs the HTTP API against the mocked ESP8266WebServer: authentication, the raw /api/custom upload and the
+// chunked preview
+
+#include <string>
+#include <unity.h>
+#include <ESP8266WebServer.h>
+
+#include "common.h"
+
+extern ESP8266WebServer httpUpdateServer;
+
+const int channels = PixelFormat<LedColor>::Channels;
+
+int put(const char *uri, const std::string &body, size_t rawChunkSize = HTTP_RAW_BUFLEN)
+{
+    return httpUpdateServer.request(HTTP_PUT, uri, body, USER_HTTP_USERNAME, USER_HTTP_PASSWORD, rawChunkSize);
+}
+
+std::string frameBytes(int leds, uint8_t first)
+{
+    std::string body;
+    for (int i = 0; i < leds * channels; i++)
+    {
+        body += (char)(uint8_t)(first + i);
+    }
+    return body;
+}
+
+void setUp()
+{
+    static bool registered = false;
+    if (!registered)
+    {
+        setupHttpApi();
+        registered = true;
+    }
+    handleCommand("on,0,0,0,0,0,0,stable");
+    memset(&customLeds, 0, sizeof(customLeds));
+}
+
+void tearDown()
+{
+}
+
+void test_get_state()
+{
+    TEST_ASSERT_EQUAL(200, httpUpdateServer.request(HTTP_GET, "/api/state", ""));
+    TEST_ASSERT_EQUAL_STRING("application/json", httpUpdateServer.responseType.c_str());
+    TEST_ASSERT_NOT_NULL(strstr(httpUpdateServer.responseBody.c_str(), "\"effect\":\"stable\""));
+}
+
+void test_put_state_requires_auth()
+{
+    TEST_ASSERT_EQUAL(401, httpUpdateServer.request(HTTP_PUT, "/api/state", "on,1,10,20,30,40,50,stable"));
+    TEST_ASSERT_EQUAL(0, colorRed);
+    TEST_ASSERT_EQUAL(401, httpUpdateServer.request(HTTP_PUT, "/api/state", "on,1,10,20,30,40,50,stable", USER_HTTP_USERNAME, "wrong"));
+    TEST_ASSERT_EQUAL(0, colorRed);
+
+    TEST_ASSERT_EQUAL(200, put("/api/state", "on,1,10,20,30,40,50,stable"));
+    TEST_ASSERT_EQUAL(10, colorRed);
+    TEST_ASSERT_NOT_NULL(strstr(httpUpdateServer.responseBody.c_str(), "\"red\":10"));
+}
+
+void test_invalid_gradient()
+{
+    TEST_ASSERT_EQUAL(400, put("/api/effect/gradient", "nonsense"));
+    TEST_ASSERT_EQUAL(404, put("/api/effect/unknown", ""));
+}
+
+void test_custom_upload()
+{
+    std::string body = frameBytes(NUM_LEDS, 1);
+    TEST_ASSERT_EQUAL(204, put("/api/custom", body));
+    TEST_ASSERT_EQUAL(eCustom, effect);
+    TEST_ASSERT_EQUAL_MEMORY(body.data(), customLeds, sizeof(customLeds));
+}
+
+void test_custom_upload_in_small_chunks()
+{
+    // Chunk boundaries don't line up with the pixels, and the body runs past the end of the frame
+    std::string body = frameBytes(NUM_LEDS + 5, 7);
+    TEST_ASSERT_EQUAL(204, put("/api/custom", body, 7));
+    TEST_ASSERT_EQUAL_MEMORY(body.data(), customLeds, sizeof(customLeds));
+}
+
+void test_short_custom_upload_clears_the_rest()
+{
+    memset(&customLeds, 0xff, sizeof(customLeds));
+    std::string body = frameBytes(2, 1);
+    TEST_ASSERT_EQUAL(204, put("/api/custom", body));
+    TEST_ASSERT_EQUAL_MEMORY(body.data(), customLeds, body.size());
+    TEST_ASSERT_EQUAL_UINT8(0, PixelFormat<LedColor>::channel(customLeds[2], 0));
+    TEST_ASSERT_EQUAL_UINT8(0, PixelFormat<LedColor>::channel(customLeds[NUM_LEDS - 1], channels - 1));
+}
+
+void test_custom_upload_requires_auth()
+{
+    memset(&customLeds, 0x55, sizeof(customLeds));
+    TEST_ASSERT_EQUAL(401, httpUpdateServer.request(HTTP_PUT, "/api/custom", frameBytes(NUM_LEDS, 1)));
+    TEST_ASSERT_EQUAL(eStable, effect);
+    TEST_ASSERT_EQUAL_UINT8(0x55, PixelFormat<LedColor>::channel(customLeds[0], 0));
+
+    // An unauthorized empty body doesn't clear the frame either
+    TEST_ASSERT_EQUAL(401, httpUpdateServer.request(HTTP_PUT, "/api/custom", ""));
+    TEST_ASSERT_EQUAL_UINT8(0x55, PixelFormat<LedColor>::channel(customLeds[0], 0));
+}
+
+void test_aborted_custom_upload()
+{
+    // The aborted upload leaves neither half a frame nor an authorized upload behind
+    memset(&customLeds, 0x55, sizeof(customLeds));
+    TEST_ASSERT_EQUAL(0, httpUpdateServer.request(HTTP_PUT, "/api/custom", frameBytes(NUM_LEDS, 1), USER_HTTP_USERNAME, USER_HTTP_PASSWORD, 16, 32));
+    TEST_ASSERT_EQUAL(eStable, effect);
+    for (int i = 0; i < NUM_LEDS; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(0, PixelFormat<LedColor>::channel(customLeds[i], 0));
+    }
+
+    memset(&customLeds, 0x55, sizeof(customLeds));
+    TEST_ASSERT_EQUAL(204, put("/api/custom", ""));
+    TEST_ASSERT_EQUAL_UINT8(0, PixelFormat<LedColor>::channel(customLeds[0], 0));
+}
+
+void test_empty_custom_upload_clears_the_frame()
+{
+    memset(&customLeds, 0x55, sizeof(customLeds));
+    TEST_ASSERT_EQUAL(204, put("/api/custom", ""));
+    TEST_ASSERT_EQUAL(eCustom, effect);
+    for (int i = 0; i < NUM_LEDS; i++)
+    {
+        for (int c = 0; c < channels; c++)
+        {
+            TEST_ASSERT_EQUAL_UINT8(0, PixelFormat<LedColor>::channel(customLeds[i], c));
+        }
+    }
+}
+
+void test_custom_round_trip()
+{
+    // More than one chunk, and brightness doesn't change the stored frame
+    handleCommand("on,0,0,0,0,0,10,stable");
+    std::string body = frameBytes(NUM_LEDS, 3);
+    TEST_ASSERT_EQUAL(204, put("/api/custom", body, 100));
+    TEST_ASSERT_EQUAL(200, httpUpdateServer.request(HTTP_GET, "/api/custom", ""));
+    TEST_ASSERT_EQUAL_STRING("application/octet-stream", httpUpdateServer.responseType.c_str());
+    TEST_ASSERT_EQUAL(body.size(), httpUpdateServer.contentLength);
+    TEST_ASSERT_EQUAL(body.size(), httpUpdateServer.responseBody.size());
+    TEST_ASSERT_EQUAL_MEMORY(body.data(), httpUpdateServer.responseBody.data(), body.size());
+}
+
+void test_preview()
+{
+    // NUM_LEDS is more than one chunk
+    for (int i = 0; i < NUM_LEDS; i++)
+    {
+        setOutputPixel(i, makeColor(i, i + 1, i + 2, i + 3));
+    }
+    TEST_ASSERT_EQUAL(200, httpUpdateServer.request(HTTP_GET, "/api/preview", ""));
+    TEST_ASSERT_EQUAL(NUM_LEDS * channels, httpUpdateServer.contentLength);
+    TEST_ASSERT_EQUAL(NUM_LEDS * channels, httpUpdateServer.responseBody.size());
+    for (int i = 0; i < NUM_LEDS; i++)
+    {
+        LedColor shown = getOutputPixel(i);
+        for (int c = 0; c < channels; c++)
+        {
+            TEST_ASSERT_EQUAL_UINT8(PixelFormat<LedColor>::channel(shown, c), (uint8_t)httpUpdateServer.responseBody[i * channels + c]);
+        }
+    }
+}
+
+void test_metrics()
+{
+    audioDroppedSamples = 12;
+    TEST_ASSERT_EQUAL(200, httpUpdateServer.request(HTTP_GET, "/api/metrics", ""));
+    maxHttpMicros = 3400;
+    TEST_ASSERT_EQUAL(200, httpUpdateServer.request(HTTP_GET, "/api/metrics", ""));
+    TEST_ASSERT_NOT_NULL(strstr(httpUpdateServer.responseBody.c_str(), "\"max_http_us\":3400,"));
+    TEST_ASSERT_NOT_NULL(strstr(httpUpdateServer.responseBody.c_str(), "\"audio_dropped_samples\":12}"));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_get_state);
+    RUN_TEST(test_put_state_requires_auth);
+    RUN_TEST(test_invalid_gradient);
+    RUN_TEST(test_custom_upload);
+    RUN_TEST(test_custom_upload_in_small_chunks);
+    RUN_TEST(test_short_custom_upload_clears_the_rest);
+    RUN_TEST(test_custom_upload_requires_auth);
+    RUN_TEST(test_aborted_custom_upload);
+    RUN_TEST(test_empty_custom_upload_clears_the_frame);
+    RUN_TEST(test_custom_round_trip);
+    RUN_TEST(test_preview);
+    RUN_TEST(test_metrics);
+    return UNITY_END();
+}
@@ -0,0 +1,212 @@
+// Replays recorded MQTT traffic and fuzzes callback() on the host. Built with the address and undefined behavior
+// sanitizers so that out of bounds writes in the parser and the effects fail the test instead of corrupting memory.
+
+#include <string>
+#include <unity.h>
+
+#include "common.h"
+#include "native.h"
+
+extern int sunPhase;
+
+const char *topics[] = {
+    USER_MQTT_CLIENT_NAME "/command",
+    USER_MQTT_CLIENT_NAME "/wakeAlarm",
+    USER_MQTT_CLIENT_NAME "/setGradient",
+    USER_MQTT_CLIENT_NAME "/setColorLoop",
+    USER_MQTT_CLIENT_NAME "/setCustom",
+    USER_MQTT_CLIENT_NAME "/setEnabledLeds",
+    USER_MQTT_CLIENT_NAME "/state",
+    USER_MQTT_CLIENT_NAME "/unknown",
+};
+const int topicCount = sizeof(topics) / sizeof(topics[0]);
+
+byte payload[MQTT_MAX_PACKET_SIZE + 16];
+uint32_t randomState = 1;
+
+uint32_t nextRandom()
+{
+    // xorshift32, the same sequence on every run
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+void send(const char *topic, const char *text)
+{
+    char topicCopy[64];
+    snprintf(topicCopy, sizeof(topicCopy), "%s", topic);
+    callback(topicCopy, (byte *)text, strlen(text));
+}
+
+void sendBytes(const char *topic, unsigned int length)
+{
+    char topicCopy[64];
+    snprintf(topicCopy, sizeof(topicCopy), "%s", topic);
+    callback(topicCopy, payload, length);
+}
+
+void reportLatency(const char *name, unsigned long count, unsigned long totalMicros, unsigned long maxMicros)
+{
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s: %lu messages, %lu us average, %lu us max", name, count, count ? totalMicros / count : 0, maxMicros);
+    TEST_MESSAGE(buf);
+}
+
+void setUp()
+{
+    handleCommand("on,0,0,0,0,0,0,stable");
+    memset(&enabledLeds, 0xff, sizeof(enabledLeds));
+    maxMessageMicros = 0;
+}
+
+void tearDown()
+{
+}
+
+void test_payload_filling_the_buffer()
+{
+    // A payload as long as the packet buffer used to get its terminator written past charPayload
+    memset(payload, 'f', MQTT_MAX_PACKET_SIZE);
+    sendBytes(USER_MQTT_CLIENT_NAME "/setCustom", MQTT_MAX_PACKET_SIZE);
+    TEST_ASSERT_EQUAL(eCustom, effect);
+    for (int c = 0; c < PixelFormat<LedColor>::Channels; c++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(0xff, PixelFormat<LedColor>::channel(customLeds[NUM_LEDS - 1], c));
+    }
+}
+
+void test_custom_longer_than_strip()
+{
+    std::string hex;
+    for (int i = 0; i <= NUM_LEDS; i++)
+    {
+        hex += std::string(PixelFormat<LedColor>::Channels * 2, i == NUM_LEDS ? '1' : 'a');
+    }
+    send(USER_MQTT_CLIENT_NAME "/setCustom", hex.c_str());
+    TEST_ASSERT_EQUAL_UINT8(0xaa, customLeds[NUM_LEDS - 1].R);
+}
+
+void test_enabled_leds_longer_than_mask()
+{
+    std::string hex(sizeof(enabledLeds) * 2 + 8, '0');
+    send(USER_MQTT_CLIENT_NAME "/setEnabledLeds", hex.c_str());
+    for (unsigned int i = 0; i < sizeof(enabledLeds); i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(0, enabledLeds[i]);
+    }
+}
+
+void test_sunrise_runs_to_the_end()
+{
+    // Every sunrise frame used to write the aurora one led past stripLeds
+    send(USER_MQTT_CLIENT_NAME "/wakeAlarm", "1");
+    for (int i = 0; i < 10000 && sunPhase < 256; i++)
+    {
+        timer.runPending();
+    }
+    TEST_ASSERT_EQUAL(256, sunPhase);
+    timer.runPending();
+    TEST_ASSERT_EQUAL(eSunrise, effect);
+}
+
+void test_replay_recorded_traffic()
+{
+    std::string path = __FILE__;
+    path = path.substr(0, path.find_last_of("/\\") + 1) + "replay.txt";
+    FILE *file = fopen(path.c_str(), "r");
+    TEST_ASSERT_NOT_NULL_MESSAGE(file, path.c_str());
+
+    char line[1024];
+    unsigned long count = 0, totalMicros = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        char *text = strchr(line, ' ');
+        if (line[0] == '#' || !text)
+        {
+            continue;
+        }
+        *text++ = '\0';
+        send(line, text);
+        timer.runPending();
+        count++;
+        totalMicros += messageMicros;
+    }
+    fclose(file);
+    reportLatency("replay", count, totalMicros, maxMessageMicros);
+
+    TEST_ASSERT_EQUAL_STRING(USER_MQTT_CLIENT_NAME "/state", publishedTopic);
+    TEST_ASSERT_EQUAL_STRING("on,1,10,20,30,40,50,stable", publishedPayload);
+    TEST_ASSERT_TRUE(publishedRetained);
+}
+
+void test_fuzz_callback()
+{
+    // Random bytes and mutated valid payloads on every topic, with the effect timers running in between
+    const char *seeds[] = {"on,1,255,180,120,0,200,stable", "off,2", "E 50", "18 182 255", "FF00000000FF00FF", "00F1", "600"};
+    const int seedCount = sizeof(seeds) / sizeof(seeds[0]);
+    unsigned long count = 0, totalMicros = 0;
+    for (int n = 0; n < 20000; n++)
+    {
+        unsigned int length;
+        if (nextRandom() % 4 == 0)
+        {
+            length = nextRandom() % (MQTT_MAX_PACKET_SIZE + 16);
+            for (unsigned int i = 0; i < length; i++)
+            {
+                payload[i] = nextRandom();
+            }
+        }
+        else
+        {
+            const char *seed = seeds[nextRandom() % seedCount];
+            length = strlen(seed);
+            memcpy(payload, seed, length);
+            for (int mutations = nextRandom() % 4; mutations > 0; mutations--)
+            {
+                switch (nextRandom() % 3)
+                {
+                case 0: // flip a byte
+                    payload[nextRandom() % length] = nextRandom();
+                    break;
+                case 1: // cut
+                    length = nextRandom() % length + 1;
+                    break;
+                case 2: // repeat a character up to the full packet
+                {
+                    unsigned int extra = min(nextRandom() % MQTT_MAX_PACKET_SIZE, (unsigned int)sizeof(payload) - length);
+                    memset(payload + length, payload[nextRandom() % length], extra);
+                    length += extra;
+                    break;
+                }
+                }
+            }
+        }
+        sendBytes(topics[nextRandom() % topicCount], length);
+        if (nextRandom() % 8 == 0)
+        {
+            timer.runPending();
+        }
+        count++;
+        totalMicros += messageMicros;
+
+        TEST_ASSERT_LESS_THAN(sizeof(effectStr), strlen(effectStr));
+    }
+    reportLatency("fuzz", count, totalMicros, maxMessageMicros);
+    // Loose enough for a slow CI machine with the sanitizers, but catches a parser that goes quadratic
+    TEST_ASSERT_LESS_THAN(1000, totalMicros / count);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_payload_filling_the_buffer);
+    RUN_TEST(test_custom_longer_than_strip);
+    RUN_TEST(test_enabled_leds_longer_than_mask);
+    RUN_TEST(test_sunrise_runs_to_the_end);
+    RUN_TEST(test_replay_recorded_traffic);
+    RUN_TEST(test_fuzz_callback);
+    return UNITY_END();
+}
@@ -0,0 +1,136 @@
+// Pixel format handling, run once per format by the native and native_rgb envs
+
+#include <unity.h>
+
+#include "common.h"
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_buffer_size()
+{
+    TEST_ASSERT_EQUAL(PixelFormat<LedColor>::Channels, sizeof(LedColor));
+#ifdef PIXEL_FORMAT_RGB
+    TEST_ASSERT_EQUAL(3 * NUM_LEDS, sizeof(stripLeds));
+#else
+    TEST_ASSERT_EQUAL(4 * NUM_LEDS, sizeof(stripLeds));
+#endif
+}
+
+void test_set_custom()
+{
+#ifdef PIXEL_FORMAT_RGB
+    // 6 hex digits per led
+    handleSetCustom("FF0000000aFF7");
+    TEST_ASSERT_EQUAL_UINT8(0xff, customLeds[0].R);
+    TEST_ASSERT_EQUAL_UINT8(0x00, customLeds[0].G);
+    TEST_ASSERT_EQUAL_UINT8(0x00, customLeds[0].B);
+    TEST_ASSERT_EQUAL_UINT8(0x00, customLeds[1].R);
+    TEST_ASSERT_EQUAL_UINT8(0x0a, customLeds[1].G);
+    TEST_ASSERT_EQUAL_UINT8(0xff, customLeds[1].B);
+    TEST_ASSERT_EQUAL_UINT8(0x70, customLeds[2].R); // zero padded at the end
+    TEST_ASSERT_EQUAL_UINT8(0x00, customLeds[2].G);
+#else
+    // 8 hex digits per led
+    handleSetCustom("FF0000000000FF807");
+    TEST_ASSERT_EQUAL_UINT8(0xff, customLeds[0].R);
+    TEST_ASSERT_EQUAL_UINT8(0x00, customLeds[0].G);
+    TEST_ASSERT_EQUAL_UINT8(0x00, customLeds[0].B);
+    TEST_ASSERT_EQUAL_UINT8(0x00, customLeds[0].W);
+    TEST_ASSERT_EQUAL_UINT8(0x00, customLeds[1].R);
+    TEST_ASSERT_EQUAL_UINT8(0xff, customLeds[1].B);
+    TEST_ASSERT_EQUAL_UINT8(0x80, customLeds[1].W);
+    TEST_ASSERT_EQUAL_UINT8(0x70, customLeds[2].R); // zero padded at the end
+    TEST_ASSERT_EQUAL_UINT8(0x00, customLeds[2].W);
+#endif
+    for (int c = 0; c < PixelFormat<LedColor>::Channels; c++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(0, PixelFormat<LedColor>::channel(customLeds[NUM_LEDS - 1], c));
+    }
+    TEST_ASSERT_EQUAL(eCustom, effect);
+}
+
+void test_convert_color()
+{
+    RgbwColor rgbw;
+    RgbColor rgb;
+
+    convertColor(RgbwColor(10, 20, 30, 40), rgbw);
+    TEST_ASSERT_EQUAL_UINT8(10, rgbw.R);
+    TEST_ASSERT_EQUAL_UINT8(40, rgbw.W);
+
+    // White is mixed into the colors and saturates
+    convertColor(RgbwColor(10, 20, 250, 40), rgb);
+    TEST_ASSERT_EQUAL_UINT8(50, rgb.R);
+    TEST_ASSERT_EQUAL_UINT8(60, rgb.G);
+    TEST_ASSERT_EQUAL_UINT8(255, rgb.B);
+
+    convertColor(RgbColor(1, 2, 3), rgbw);
+    TEST_ASSERT_EQUAL_UINT8(1, rgbw.R);
+    TEST_ASSERT_EQUAL_UINT8(2, rgbw.G);
+    TEST_ASSERT_EQUAL_UINT8(3, rgbw.B);
+    TEST_ASSERT_EQUAL_UINT8(0, rgbw.W);
+
+    convertColor(RgbColor(4, 5, 6), rgb);
+    TEST_ASSERT_EQUAL_UINT8(4, rgb.R);
+    TEST_ASSERT_EQUAL_UINT8(6, rgb.B);
+}
+
+void test_scale()
+{
+    RgbwColor rgbw = PixelFormat<RgbwColor>::scale(RgbwColor(200, 100, 50, 255), 0.5f);
+    TEST_ASSERT_EQUAL_UINT8(100, rgbw.R);
+    TEST_ASSERT_EQUAL_UINT8(50, rgbw.G);
+    TEST_ASSERT_EQUAL_UINT8(25, rgbw.B);
+    TEST_ASSERT_EQUAL_UINT8(127, rgbw.W);
+
+    RgbColor rgb = PixelFormat<RgbColor>::scale(RgbColor(200, 100, 255), 0.f);
+    TEST_ASSERT_EQUAL_UINT8(0, rgb.R);
+    TEST_ASSERT_EQUAL_UINT8(0, rgb.B);
+    rgb = PixelFormat<RgbColor>::scale(RgbColor(200, 100, 255), 1.f);
+    TEST_ASSERT_EQUAL_UINT8(200, rgb.R);
+    TEST_ASSERT_EQUAL_UINT8(255, rgb.B);
+}
+
+void test_make_color()
+{
+    LedColor color = makeColor(10, 20, 30, 5);
+#ifdef PIXEL_FORMAT_RGB
+    TEST_ASSERT_EQUAL_UINT8(15, color.R);
+    TEST_ASSERT_EQUAL_UINT8(25, color.G);
+    TEST_ASSERT_EQUAL_UINT8(35, color.B);
+#else
+    TEST_ASSERT_EQUAL_UINT8(10, color.R);
+    TEST_ASSERT_EQUAL_UINT8(30, color.B);
+    TEST_ASSERT_EQUAL_UINT8(5, color.W);
+#endif
+}
+
+void test_output_round_trip()
+{
+    // The default output channel matches the pixel format, so a pixel comes back unchanged
+    LedColor color = makeColor(1, 2, 3, 4);
+    setOutputPixel(NUM_LEDS - 1, color);
+    LedColor shown = getOutputPixel(NUM_LEDS - 1);
+    for (int c = 0; c < PixelFormat<LedColor>::Channels; c++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(PixelFormat<LedColor>::channel(color, c), PixelFormat<LedColor>::channel(shown, c));
+    }
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_buffer_size);
+    RUN_TEST(test_set_custom);
+    RUN_TEST(test_convert_color);
+    RUN_TEST(test_scale);
+    RUN_TEST(test_make_color);
+    RUN_TEST(test_output_round_trip);
+    return UNITY_END();
+}